@@ -65,7 +65,7 @@ void aes_encrypt_buffer(aes_struct* aes_config_struct)
     }
     else
     {
-        // aes_encrypt_ctr(aes_config_struct);
+        aes_encrypt_ctr(aes_config_struct);
     }
 }
 
@@ -83,6 +83,59 @@ void aes_encrypt_ecb(aes_struct* aes_config_struct)
     }
 }
 
+// Function to encrypt the buffer in CTR mode
+void aes_encrypt_ctr(aes_struct* aes_config_struct)
+{
+    uint8_t counter[AES_BLK_LENGTH];
+
+    // Work on a copy so that the IV of the caller is not modified
+    memcpy(counter, aes_config_struct->counter, AES_BLK_LENGTH);
+
+    // Encrypted counter blocks are written directly to the cipher buffer
+    aes_ctr_keystream(aes_config_struct->cipher_text, aes_config_struct->plain_text_length, counter, aes_config_struct->aes_key_length, aes_config_struct->round_key);
+
+    // XOR the encrypted counter with the plain text
+    for(int i = 0; i < aes_config_struct->plain_text_length; i++)
+    {
+        aes_config_struct->cipher_text[i] ^= aes_config_struct->plain_text[i];
+    }
+}
+
+/* Function to generate the CTR keystream i.e; the encrypted counter blocks. The
+ * counter is incremented after each block so on return it holds the next unused
+ * counter value. A partial last block is truncated.
+ */
+void aes_ctr_keystream(uint8_t* keystream, int keystream_length, uint8_t* counter, uint8_t key_length, uint8_t* round_key)
+{
+    uint8_t last_block[AES_BLK_LENGTH];
+    int i = 0;
+
+    for(; i + AES_BLK_LENGTH <= keystream_length; i = i + AES_BLK_LENGTH)
+    {
+        aes_encrypt_state(keystream + i, counter, key_length, round_key);
+        aes_increment_counter(counter);
+    }
+
+    if(i < keystream_length)
+    {
+        aes_encrypt_state(last_block, counter, key_length, round_key);
+        aes_increment_counter(counter);
+        memcpy(keystream + i, last_block, keystream_length - i);
+    }
+}
+
+// Function to increment the counter as a 128 bit big endian number
+void aes_increment_counter(uint8_t* counter)
+{
+    for(int i = AES_BLK_LENGTH - 1; i >= 0; i--)
+    {
+        if(++counter[i] != 0)
+        {
+            break;
+        }
+    }
+}
+
 // Function to compute AES encryption per block
 void aes_encrypt_state(uint8_t* state_ptr_cipher_text, const uint8_t* state_ptr_plain_text, uint8_t key_length, uint8_t* round_key)
 {
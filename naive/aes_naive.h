@@ -46,6 +46,8 @@ uint8_t aes_sbox_get_val(uint8_t byte_val);
 void aes_encrypt_buffer(aes_struct* aes_config_struct);
 void aes_encrypt_ecb(aes_struct* aes_config_struct);
 void aes_encrypt_ctr(aes_struct* aes_config_struct);
+void aes_ctr_keystream(uint8_t* keystream, int keystream_length, uint8_t* counter, uint8_t key_length, uint8_t* round_key);
+void aes_increment_counter(uint8_t* counter);
 void aes_encrypt_state(uint8_t* state_ptr_cipher_text, const uint8_t* state_ptr_plain_text, uint8_t key_length, uint8_t* round_key);
 void aes_add_round_key(uint8_t* buffer, uint8_t* round_key);
 void aes_sub_bytes(uint8_t* buffer);
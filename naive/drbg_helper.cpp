@@ -0,0 +1,227 @@
+/******************************************************************************
+ * File Name    - drbg_helper.cpp
+ *
+ * Description  - This cpp file contains the function definitions of the AES
+ *                CTR_DRBG (NIST SP 800-90A, no derivation function) used to
+ *                generate keys, IVs and random plain text
+ ******************************************************************************/
+#include "string.h"
+#include <errno.h>
+#include <sys/random.h>
+
+#include "drbg_helper.h"
+#include "key_helper.h"
+
+/*******************************************************************************
+* Global variables
+*******************************************************************************/
+// Each thread owns a DRBG instance and a buffer of already generated bytes
+static thread_local drbg_struct thread_drbg;
+static thread_local bool thread_drbg_ready = false;
+static thread_local uint8_t thread_buffer[DRBG_BUFFER_LENGTH];
+static thread_local int thread_buffer_offset = DRBG_BUFFER_LENGTH;
+
+/* Function for the CTR_DRBG update step. The counter passed is V + 1 and the
+ * provided data is zero padded to the seed length.
+ */
+static void drbg_update(drbg_struct* drbg, const uint8_t* provided_data, int provided_data_length, uint8_t* counter)
+{
+    uint8_t temp[DRBG_SEED_LENGTH];
+
+    aes_ctr_keystream(temp, DRBG_SEED_LENGTH, counter, AES_KEY_SIZE, drbg->round_key);
+
+    if(provided_data_length > DRBG_SEED_LENGTH)
+    {
+        provided_data_length = DRBG_SEED_LENGTH;
+    }
+
+    for(int i = 0; i < provided_data_length; i++)
+    {
+        temp[i] ^= provided_data[i];
+    }
+
+    // Leftmost bytes form the new key and the rightmost bytes the new V
+    memcpy(drbg->key, temp, AES_KEY_SIZE_BYTES);
+    memcpy(drbg->v, temp + AES_KEY_SIZE_BYTES, AES_BLK_LENGTH);
+    key_helper_create_round_keys(AES_MODE, AES_KEY_SIZE, drbg->key, drbg->round_key);
+
+    memset(temp, 0, DRBG_SEED_LENGTH);
+}
+
+// Function to fetch the per thread DRBG instance. Instantiated on first use
+static drbg_struct* drbg_get_thread_instance()
+{
+    if(!thread_drbg_ready)
+    {
+        // The address of the instance is unique per thread and is used as personalization
+        uintptr_t thread_id = (uintptr_t)&thread_drbg;
+
+        drbg_helper_instantiate(&thread_drbg, (const uint8_t*)&thread_id, sizeof(thread_id));
+        thread_drbg_ready = true;
+    }
+
+    return &thread_drbg;
+}
+
+// Function to read entropy from the kernel
+void drbg_helper_get_entropy(uint8_t* entropy, size_t entropy_length)
+{
+    size_t offset = 0;
+
+    while(offset < entropy_length)
+    {
+        ssize_t ret = getrandom(entropy + offset, entropy_length - offset, 0);
+
+        if(ret < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+
+            fprintf(stderr, "ERROR: getrandom failed - %s\n", strerror(errno));
+            exit(EXIT_FAILURE);
+        }
+
+        offset += ret;
+    }
+}
+
+// Function to instantiate the DRBG with fresh entropy
+void drbg_helper_instantiate(drbg_struct* drbg, const uint8_t* personalization, int personalization_length)
+{
+    uint8_t seed_material[DRBG_SEED_LENGTH];
+    uint8_t counter[AES_BLK_LENGTH];
+
+    drbg_helper_get_entropy(seed_material, DRBG_SEED_LENGTH);
+
+    for(int i = 0; (i < personalization_length) && (i < DRBG_SEED_LENGTH); i++)
+    {
+        seed_material[i] ^= personalization[i];
+    }
+
+    // Key and V start as all zeros
+    memset(drbg->key, 0, AES_KEY_SIZE_BYTES);
+    memset(drbg->v, 0, AES_BLK_LENGTH);
+    key_helper_create_round_keys(AES_MODE, AES_KEY_SIZE, drbg->key, drbg->round_key);
+
+    memcpy(counter, drbg->v, AES_BLK_LENGTH);
+    aes_increment_counter(counter);
+    drbg_update(drbg, seed_material, DRBG_SEED_LENGTH, counter);
+
+    drbg->reseed_counter = 1;
+
+    memset(seed_material, 0, DRBG_SEED_LENGTH);
+}
+
+// Function to mix fresh entropy into the DRBG state
+void drbg_helper_reseed(drbg_struct* drbg, const uint8_t* additional_input, int additional_input_length)
+{
+    uint8_t seed_material[DRBG_SEED_LENGTH];
+    uint8_t counter[AES_BLK_LENGTH];
+
+    drbg_helper_get_entropy(seed_material, DRBG_SEED_LENGTH);
+
+    for(int i = 0; (i < additional_input_length) && (i < DRBG_SEED_LENGTH); i++)
+    {
+        seed_material[i] ^= additional_input[i];
+    }
+
+    memcpy(counter, drbg->v, AES_BLK_LENGTH);
+    aes_increment_counter(counter);
+    drbg_update(drbg, seed_material, DRBG_SEED_LENGTH, counter);
+
+    drbg->reseed_counter = 1;
+
+    memset(seed_material, 0, DRBG_SEED_LENGTH);
+}
+
+// Function to generate up to DRBG_MAX_REQUEST_LENGTH random bytes
+void drbg_helper_generate(drbg_struct* drbg, uint8_t* output, int output_length, const uint8_t* additional_input, int additional_input_length)
+{
+    uint8_t counter[AES_BLK_LENGTH];
+
+    if(output_length > DRBG_MAX_REQUEST_LENGTH)
+    {
+        fprintf(stderr, "ERROR: DRBG request of %d bytes exceeds the maximum request length\n", output_length);
+        exit(EXIT_FAILURE);
+    }
+
+    if(drbg->reseed_counter > DRBG_RESEED_INTERVAL)
+    {
+        // Additional input is consumed by the reseed
+        drbg_helper_reseed(drbg, additional_input, additional_input_length);
+        additional_input_length = 0;
+    }
+
+    if(additional_input_length > 0)
+    {
+        memcpy(counter, drbg->v, AES_BLK_LENGTH);
+        aes_increment_counter(counter);
+        drbg_update(drbg, additional_input, additional_input_length, counter);
+    }
+
+    // Output blocks are E(V + 1), E(V + 2) ... which is the CTR keystream from V + 1
+    memcpy(counter, drbg->v, AES_BLK_LENGTH);
+    aes_increment_counter(counter);
+    aes_ctr_keystream(output, output_length, counter, AES_KEY_SIZE, drbg->round_key);
+
+    // Counter is now one past the last output block i.e; V + 1 for the update step
+    drbg_update(drbg, additional_input, additional_input_length, counter);
+
+    drbg->reseed_counter++;
+}
+
+/* Function to get random bytes for keys and IVs. Small requests are served from
+ * the per thread buffer so that a DRBG request is not issued for every IV.
+ */
+void drbg_helper_random_bytes(uint8_t* output, size_t output_length)
+{
+    if(output_length >= DRBG_BUFFER_LENGTH)
+    {
+        drbg_helper_fill_buffer(output, output_length);
+        return;
+    }
+
+    while(output_length > 0)
+    {
+        if(thread_buffer_offset == DRBG_BUFFER_LENGTH)
+        {
+            drbg_helper_generate(drbg_get_thread_instance(), thread_buffer, DRBG_BUFFER_LENGTH, NULL, 0);
+            thread_buffer_offset = 0;
+        }
+
+        size_t copy_length = DRBG_BUFFER_LENGTH - thread_buffer_offset;
+
+        if(copy_length > output_length)
+        {
+            copy_length = output_length;
+        }
+
+        // Bytes handed out are wiped so that they can not be recovered later
+        memcpy(output, thread_buffer + thread_buffer_offset, copy_length);
+        memset(thread_buffer + thread_buffer_offset, 0, copy_length);
+
+        thread_buffer_offset += copy_length;
+        output += copy_length;
+        output_length -= copy_length;
+    }
+}
+
+// Function to fill a large buffer with random bytes, one maximum sized request at a time
+void drbg_helper_fill_buffer(uint8_t* output, size_t output_length)
+{
+    drbg_struct* drbg = drbg_get_thread_instance();
+
+    for(size_t offset = 0; offset < output_length; offset += DRBG_MAX_REQUEST_LENGTH)
+    {
+        size_t request_length = output_length - offset;
+
+        if(request_length > DRBG_MAX_REQUEST_LENGTH)
+        {
+            request_length = DRBG_MAX_REQUEST_LENGTH;
+        }
+
+        drbg_helper_generate(drbg, output + offset, (int)request_length, NULL, 0);
+    }
+}
@@ -0,0 +1,51 @@
+/******************************************************************************
+ * File Name    - drbg_helper.h
+ *
+ * Description  - This is the header file for the drbg_helper code
+ ******************************************************************************/
+
+#ifndef SOURCE_DRBG_HELPER_H_
+#define SOURCE_DRBG_HELPER_H_
+
+#include "main.h"
+#include "aes_naive.h"
+
+/*******************************************************************************
+* Global constants
+*******************************************************************************/
+// CTR_DRBG without derivation function - seed is key followed by V
+#define DRBG_SEED_LENGTH            (AES_KEY_SIZE_BYTES + AES_BLK_LENGTH)
+
+// Maximum bytes per generate request (SP 800-90A limit of 2^19 bits)
+#define DRBG_MAX_REQUEST_LENGTH     65536
+
+// Number of generate requests after which fresh entropy is fetched
+#define DRBG_RESEED_INTERVAL        (1ULL << 24)
+
+// Per thread buffer used to serve small requests like keys and IVs
+#define DRBG_BUFFER_LENGTH          4096
+
+/*******************************************************************************
+* Structures and enumerations
+*******************************************************************************/
+typedef struct drbg_struct
+{
+    uint8_t key[AES_KEY_SIZE_BYTES];                    // Current DRBG key
+    uint8_t round_key[AES256_ROUND_KEY_LENGTH];         // Expanded DRBG key
+    uint8_t v[AES_BLK_LENGTH];                          // Current DRBG counter V
+    uint64_t reseed_counter;                            // Requests since last reseed
+} drbg_struct;
+
+/*******************************************************************************
+* Function prototypes
+*******************************************************************************/
+void drbg_helper_instantiate(drbg_struct* drbg, const uint8_t* personalization, int personalization_length);
+void drbg_helper_reseed(drbg_struct* drbg, const uint8_t* additional_input, int additional_input_length);
+void drbg_helper_generate(drbg_struct* drbg, uint8_t* output, int output_length, const uint8_t* additional_input, int additional_input_length);
+void drbg_helper_random_bytes(uint8_t* output, size_t output_length);
+void drbg_helper_fill_buffer(uint8_t* output, size_t output_length);
+void drbg_helper_get_entropy(uint8_t* entropy, size_t entropy_length);
+
+#endif /* SOURCE_DRBG_HELPER_H_ */
+
+/* [] END OF FILE */
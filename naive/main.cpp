@@ -5,13 +5,13 @@
  *                acceleration using GPU. This file is the main code which 
  *                demonstrates the use of naive AES implementation
  ******************************************************************************/
-#include <random>
 #include <assert.h>
 #include <chrono>
 
 #include "main.h"
 #include "aes_naive.h"
 #include "key_helper.h"
+#include "drbg_helper.h"
 
 /*******************************************************************************
 * Global constants
@@ -76,6 +76,9 @@ int main(int argc, char* argv[])
     // Structure to store all AES configuration
     aes_struct encrypt_struct;
 
+    // Variable to store IV for CTR mode
+    uint8_t counter[AES_BLK_LENGTH];
+
 #if USE_DEFAULT_INPUTS
     int plain_text_size = sizeof(default_plain_text)/sizeof(uint8_t);
 
@@ -88,21 +91,9 @@ int main(int argc, char* argv[])
     uint8_t* plain_text = new uint8_t[plain_text_size];
     uint8_t* key = new uint8_t[AES_KEY_SIZE_BYTES];
     
-    // Generating random numbers for array with the arbitrary range
-    std::random_device entropy_source_input;
-    std::mt19937 generator_input(entropy_source_input()); 
-    std::uniform_int_distribution<int> dist_plain_text(0, 255);
-    std::uniform_int_distribution<int> dist_key(0, 255);
-
-    for(int i = 0; i < plain_text_size; i++)
-    {
-        plain_text[i] = dist_plain_text(generator_input);
-
-        if(i < AES_KEY_SIZE_BYTES)
-        {
-            key[i] = dist_key(generator_input);
-        }
-    }
+    // Generating random key and plain text using the AES CTR_DRBG
+    drbg_helper_random_bytes(key, AES_KEY_SIZE_BYTES);
+    drbg_helper_fill_buffer(plain_text, plain_text_size);
     encrypt_struct.plain_text = plain_text;
     encrypt_struct.plain_text_length = plain_text_size;
     encrypt_struct.key = key;
@@ -128,17 +119,8 @@ int main(int argc, char* argv[])
 
     if(encrypt_struct.aes_mode == AES_CTR)
     {
-        // Generating random numbers for the initialization vector (IV) counter
-        std::random_device entropy_source;
-        std::mt19937 generator(entropy_source()); 
-        std::uniform_int_distribution<int> dist(0, 255);
-
-        uint8_t counter[AES_BLK_LENGTH];
-
-        for(int i = 0; i < AES_BLK_LENGTH; i++)
-        {
-            counter[i] = dist(generator);
-        }
+        // Generating random initialization vector (IV) counter
+        drbg_helper_random_bytes(counter, AES_BLK_LENGTH);
 
         encrypt_struct.counter = counter;
     }
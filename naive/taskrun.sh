@@ -6,7 +6,7 @@
 #SBATCH -o AESSlurm.out -e AESSlurm.err
 
 # Compile the code
-g++ key_helper.cpp aes_naive.cpp main.cpp -Wall -O3 -std=c++17 -o main
+g++ key_helper.cpp aes_naive.cpp drbg_helper.cpp main.cpp -Wall -O3 -std=c++17 -o main
 
 # Command to run the code for default inputs
 # ./main
@@ -6,9 +6,14 @@
  ******************************************************************************/
 #include "string.h"
 #include <cuda.h>
+#include <omp.h>
 
 #include "aes_parallel.cuh"
 
+#if AES_USE_AESNI
+#include <wmmintrin.h>
+#endif
+
 /*******************************************************************************
 * Global constants
 *******************************************************************************/
@@ -36,6 +41,9 @@ static const uint8_t sbox[SBOX_LENGTH] = {
 // Combined buffer to save shift row constants and matrix of mix column step
 static const int8_t comb_const[32] = {0, 12, 8, 4, 0, -4, 8, 4, 0, -4, -8, 4, 0, -4, -8, -12, 2, 3, 1, 1, 1, 2, 3, 1, 1, 1, 2, 3, 3, 1, 1, 2};
 
+// Host lookup tables combining the sub bytes, shift rows and mix columns steps
+static uint32_t te_table[4][SBOX_LENGTH];
+
 // Ref - https://stackoverflow.com/questions/14038589/what-is-the-canonical-way-to-check-for-errors-using-the-cuda-runtime-api
 #define gpuErrchk(ans) { gpuAssert((ans), __FILE__, __LINE__); }
 inline void gpuAssert(cudaError_t code, const char *file, int line, bool abort=true)
@@ -108,18 +116,17 @@ void aes_encrypt_ctr(aes_struct* aes_config_struct)
 
     // IV is encrypted in CTR mode
     uint8_t* ctr_buf = new uint8_t[aes_config_struct->plain_text_length];
+    uint8_t counter[AES_BLK_LENGTH];
 
-    for(int i = 0; i < aes_config_struct->plain_text_length; i++)
+    memcpy(counter, aes_config_struct->counter, AES_BLK_LENGTH);
+
+    for(int i = 0; i < aes_config_struct->plain_text_length; i = i + AES_BLK_LENGTH)
     {
-        // Copy the IV to the buffer. IV is incremented for each block
-        if((i % AES_BLK_LENGTH == 15) && (i != 15))
-        {
-            ctr_buf[i] = ctr_buf[i - AES_BLK_LENGTH] + 1;
-        }
-        else
-        {
-            ctr_buf[i] = aes_config_struct->counter[i % 16];
-        }
+        // Copy the IV to the buffer. IV is incremented for each block. The last block may be partial
+        int copy_length = (aes_config_struct->plain_text_length - i < AES_BLK_LENGTH) ? (aes_config_struct->plain_text_length - i) : AES_BLK_LENGTH;
+
+        memcpy(&ctr_buf[i], counter, copy_length);
+        aes_increment_counter(counter);
     }
 
     // Reuse of the same code used for ECB mode
@@ -160,6 +167,9 @@ void aes_encrypt_ctr(aes_struct* aes_config_struct)
         aes_config_struct->cipher_text[i] = aes_config_struct->cipher_text[i] ^ plain_text_buf[i];
     }
 
+    // Give the caller back its plain text, ctr_buf is freed below
+    aes_config_struct->plain_text = plain_text_buf;
+
     delete [] ctr_buf;
     cudaFree(dev_sbox_arr);
     cudaFree(dev_round_key);
@@ -223,7 +233,375 @@ void aes_encrypt_ecb(aes_struct* aes_config_struct)
     cudaFree(dev_comb_arr);
 }
 
-__device__ inline uint8_t aes_galoi_mult(uint8_t num, uint8_t mult)
+// Function to (re)allocate the text buffers of the device
+static void aes_device_reserve(aes_device_struct* device, int length)
+{
+    if(length <= device->capacity)
+    {
+        return;
+    }
+
+    cudaFree(device->dev_plain_text);
+    cudaFree(device->dev_cipher_text);
+    cudaMalloc((void**)&device->dev_plain_text, sizeof(uint8_t) * length);
+    cudaMalloc((void**)&device->dev_cipher_text, sizeof(uint8_t) * length);
+    device->capacity = length;
+}
+
+/* Function to prepare the device for repeated encryption. Creating the CUDA
+ * context, allocating the buffers and uploading the constants is done here once
+ * instead of in every call, so aes_device_encrypt_buffer only pays for the
+ * transfers of the text and the kernel.
+ */
+void aes_device_init(aes_device_struct* device, int capacity)
+{
+    memset(device, 0, sizeof(aes_device_struct));
+
+    // Forces the creation of the CUDA context
+    cudaFree(0);
+
+    cudaMalloc((void**)&device->dev_sbox_arr, sizeof(uint8_t) * SBOX_LENGTH);
+    cudaMalloc((void**)&device->dev_comb_arr, sizeof(int8_t) * 32);
+    cudaMalloc((void**)&device->dev_round_key, sizeof(uint8_t) * AES256_ROUND_KEY_LENGTH);
+
+    cudaMemcpy(device->dev_sbox_arr, sbox, sizeof(uint8_t) * SBOX_LENGTH, cudaMemcpyHostToDevice);
+    cudaMemcpy(device->dev_comb_arr, comb_const, sizeof(int8_t) * 32, cudaMemcpyHostToDevice);
+
+    aes_device_reserve(device, capacity);
+}
+
+// Function to encrypt the buffer in ECB or CTR mode with the prepared device
+void aes_device_encrypt_buffer(aes_device_struct* device, aes_struct* aes_config_struct)
+{
+    int length = aes_config_struct->plain_text_length;
+    int block_count = (length + THREADS_PER_BLOCK - 1)/THREADS_PER_BLOCK;
+    int smem_size = sizeof(uint8_t) * (SBOX_LENGTH + 2*THREADS_PER_BLOCK + AES256_ROUND_KEY_LENGTH) + sizeof(int8_t) * 32;
+    uint8_t num_rounds = (aes_config_struct->aes_key_length == AES128_KEY_SIZE*8) ? AES128_ROUNDS : AES256_ROUNDS;
+    uint8_t* ctr_buf = NULL;
+
+    if(length <= 0)
+    {
+        return;
+    }
+
+    aes_device_reserve(device, length);
+
+    // The round key is only uploaded when the key changes
+    if((device->round_key_length != aes_config_struct->round_key_length) || (memcmp(device->round_key, aes_config_struct->round_key, aes_config_struct->round_key_length) != 0))
+    {
+        cudaMemcpy(device->dev_round_key, aes_config_struct->round_key, sizeof(uint8_t) * aes_config_struct->round_key_length, cudaMemcpyHostToDevice);
+        memcpy(device->round_key, aes_config_struct->round_key, aes_config_struct->round_key_length);
+        device->round_key_length = aes_config_struct->round_key_length;
+    }
+
+    if(aes_config_struct->aes_mode == AES_CTR)
+    {
+        // Counter blocks are encrypted and the plain text is added on the host
+        uint8_t counter[AES_BLK_LENGTH];
+
+        ctr_buf = new uint8_t[length];
+        memcpy(counter, aes_config_struct->counter, AES_BLK_LENGTH);
+
+        for(int i = 0; i < length; i = i + AES_BLK_LENGTH)
+        {
+            int copy_length = (length - i < AES_BLK_LENGTH) ? (length - i) : AES_BLK_LENGTH;
+
+            memcpy(&ctr_buf[i], counter, copy_length);
+            aes_increment_counter(counter);
+        }
+
+        cudaMemcpy(device->dev_plain_text, ctr_buf, sizeof(uint8_t) * length, cudaMemcpyHostToDevice);
+    }
+    else
+    {
+        cudaMemcpy(device->dev_plain_text, aes_config_struct->plain_text, sizeof(uint8_t) * length, cudaMemcpyHostToDevice);
+    }
+
+    aes_ecb_gpu_encryption_kernel<<<block_count, THREADS_PER_BLOCK, smem_size>>>(device->dev_sbox_arr, device->dev_round_key, aes_config_struct->round_key_length, device->dev_plain_text, length, num_rounds, device->dev_comb_arr, device->dev_cipher_text);
+
+    cudaDeviceSynchronize();
+
+    cudaMemcpy(aes_config_struct->cipher_text, device->dev_cipher_text, sizeof(uint8_t) * length, cudaMemcpyDeviceToHost);
+
+    if(ctr_buf != NULL)
+    {
+        for(int i = 0; i < length; i++)
+        {
+            aes_config_struct->cipher_text[i] ^= aes_config_struct->plain_text[i];
+        }
+
+        delete [] ctr_buf;
+    }
+}
+
+// Function to free the buffers of the device
+void aes_device_release(aes_device_struct* device)
+{
+    cudaFree(device->dev_sbox_arr);
+    cudaFree(device->dev_comb_arr);
+    cudaFree(device->dev_round_key);
+    cudaFree(device->dev_plain_text);
+    cudaFree(device->dev_cipher_text);
+    memset(device, 0, sizeof(aes_device_struct));
+}
+
+/* Host implementation of AES used where the GPU is not involved, for example 
+ * by the DRBG
+ */
+
+// Function to generate the CTR keystream. On return counter holds the next unused value
+void aes_ctr_keystream(uint8_t* keystream, int keystream_length, uint8_t* counter, uint8_t key_length, uint8_t* round_key)
+{
+    uint8_t last_block[AES_BLK_LENGTH];
+    int i = 0;
+
+    for(; i + AES_BLK_LENGTH <= keystream_length; i = i + AES_BLK_LENGTH)
+    {
+        aes_encrypt_state(keystream + i, counter, key_length, round_key);
+        aes_increment_counter(counter);
+    }
+
+    // Partial last block is truncated
+    if(i < keystream_length)
+    {
+        aes_encrypt_state(last_block, counter, key_length, round_key);
+        aes_increment_counter(counter);
+        memcpy(keystream + i, last_block, keystream_length - i);
+    }
+}
+
+// Function to increment the counter as a 128 bit big endian number
+void aes_increment_counter(uint8_t* counter)
+{
+    for(int i = AES_BLK_LENGTH - 1; i >= 0; i--)
+    {
+        if(++counter[i] != 0)
+        {
+            break;
+        }
+    }
+}
+
+// Function to add a block count to the counter as a 128 bit big endian number
+void aes_add_counter(uint8_t* counter, uint64_t block_count)
+{
+    uint16_t carry = 0;
+
+    for(int i = AES_BLK_LENGTH - 1; i >= 0; i--)
+    {
+        carry += counter[i] + (block_count & 0xff);
+        counter[i] = carry & 0xff;
+        carry >>= 8;
+        block_count >>= 8;
+    }
+}
+
+/* Function to encrypt the buffer on the host in ECB or CTR mode. The blocks are
+ * divided evenly among num_threads OpenMP threads.
+ */
+void aes_encrypt_buffer_host(aes_struct* aes_config_struct, int num_threads)
+{
+    long long block_count = (aes_config_struct->plain_text_length + AES_BLK_LENGTH - 1) / AES_BLK_LENGTH;
+
+    #pragma omp parallel num_threads(num_threads)
+    {
+        long long first_block = block_count * omp_get_thread_num() / omp_get_num_threads();
+        long long last_block = block_count * (omp_get_thread_num() + 1) / omp_get_num_threads();
+        int offset = first_block * AES_BLK_LENGTH;
+        int length = ((last_block == block_count) ? aes_config_struct->plain_text_length : last_block * AES_BLK_LENGTH) - offset;
+
+        if(aes_config_struct->aes_mode == AES_ECB)
+        {
+            for(int i = offset; i < offset + length; i = i + AES_BLK_LENGTH)
+            {
+                aes_encrypt_state(aes_config_struct->cipher_text + i, aes_config_struct->plain_text + i, aes_config_struct->aes_key_length, aes_config_struct->round_key);
+            }
+        }
+        else if(length > 0)
+        {
+            uint8_t counter[AES_BLK_LENGTH];
+
+            // Counter of the first block handled by this thread
+            memcpy(counter, aes_config_struct->counter, AES_BLK_LENGTH);
+            aes_add_counter(counter, first_block);
+
+            aes_ctr_keystream(aes_config_struct->cipher_text + offset, length, counter, aes_config_struct->aes_key_length, aes_config_struct->round_key);
+
+            for(int i = offset; i < offset + length; i++)
+            {
+                aes_config_struct->cipher_text[i] ^= aes_config_struct->plain_text[i];
+            }
+        }
+    }
+}
+
+// Function to build the host lookup tables
+static bool aes_init_te_table()
+{
+    for(int i = 0; i < SBOX_LENGTH; i++)
+    {
+        uint8_t s = sbox[i];
+        uint32_t word = ((uint32_t)aes_galoi_mult(s, 2) << 24) | ((uint32_t)s << 16) | ((uint32_t)s << 8) | aes_galoi_mult(s, 3);
+
+        // Each table is the previous one rotated by a byte
+        for(int j = 0; j < 4; j++)
+        {
+            te_table[j][i] = word;
+            word = (word >> 8) | (word << 24);
+        }
+    }
+
+    return true;
+}
+
+static const bool te_table_ready = aes_init_te_table();
+
+// Helper functions to move between bytes and big endian column words
+static inline uint32_t aes_load_word(const uint8_t* buffer)
+{
+    return ((uint32_t)buffer[0] << 24) | ((uint32_t)buffer[1] << 16) | ((uint32_t)buffer[2] << 8) | buffer[3];
+}
+
+static inline void aes_store_word(uint8_t* buffer, uint32_t word)
+{
+    buffer[0] = word >> 24;
+    buffer[1] = word >> 16;
+    buffer[2] = word >> 8;
+    buffer[3] = word;
+}
+
+// Function for one middle round on the column words - sub bytes, shift rows, mix columns and add round key
+static inline void aes_te_round(uint32_t* state, const uint8_t* round_key_ptr)
+{
+    uint32_t t0, t1, t2, t3;
+
+    t0 = te_table[0][state[0] >> 24] ^ te_table[1][(state[1] >> 16) & 0xff] ^ te_table[2][(state[2] >> 8) & 0xff] ^ te_table[3][state[3] & 0xff] ^ aes_load_word(round_key_ptr);
+    t1 = te_table[0][state[1] >> 24] ^ te_table[1][(state[2] >> 16) & 0xff] ^ te_table[2][(state[3] >> 8) & 0xff] ^ te_table[3][state[0] & 0xff] ^ aes_load_word(round_key_ptr + 4);
+    t2 = te_table[0][state[2] >> 24] ^ te_table[1][(state[3] >> 16) & 0xff] ^ te_table[2][(state[0] >> 8) & 0xff] ^ te_table[3][state[1] & 0xff] ^ aes_load_word(round_key_ptr + 8);
+    t3 = te_table[0][state[3] >> 24] ^ te_table[1][(state[0] >> 16) & 0xff] ^ te_table[2][(state[1] >> 8) & 0xff] ^ te_table[3][state[2] & 0xff] ^ aes_load_word(round_key_ptr + 12);
+
+    state[0] = t0;
+    state[1] = t1;
+    state[2] = t2;
+    state[3] = t3;
+}
+
+// Function for the last round on the column words, storing the result as bytes
+static inline void aes_te_last_round(uint8_t* output, const uint32_t* state, const uint8_t* round_key_ptr)
+{
+    for(int c = 0; c < 4; c++)
+    {
+        uint32_t word = ((uint32_t)sbox[state[c] >> 24] << 24) | ((uint32_t)sbox[(state[(c + 1) % 4] >> 16) & 0xff] << 16) | ((uint32_t)sbox[(state[(c + 2) % 4] >> 8) & 0xff] << 8) | sbox[state[(c + 3) % 4] & 0xff];
+
+        aes_store_word(output + c * 4, word ^ aes_load_word(round_key_ptr + c * 4));
+    }
+}
+
+/* Function to compute AES encryption per block on the host. With AES-NI
+ * available (-maes) the aesenc instructions are used. Otherwise the state is
+ * held as 4 column words and sub bytes, shift rows and mix columns of a round
+ * are done together with one lookup per byte.
+ */
+void aes_encrypt_state(uint8_t* state_ptr_cipher_text, const uint8_t* state_ptr_plain_text, uint8_t key_length, uint8_t* round_key)
+{
+    uint8_t num_rounds = (key_length == AES128_KEY_SIZE*8) ? AES128_ROUNDS : AES256_ROUNDS;
+
+#if AES_USE_AESNI
+    __m128i state = _mm_xor_si128(_mm_loadu_si128((const __m128i*)state_ptr_plain_text), _mm_loadu_si128((const __m128i*)round_key));
+
+    for(uint8_t curr_round = 1; curr_round < num_rounds - 1; curr_round++)
+    {
+        state = _mm_aesenc_si128(state, _mm_loadu_si128((const __m128i*)(round_key + curr_round * AES_BLK_LENGTH)));
+    }
+
+    _mm_storeu_si128((__m128i*)state_ptr_cipher_text, _mm_aesenclast_si128(state, _mm_loadu_si128((const __m128i*)(round_key + (num_rounds - 1) * AES_BLK_LENGTH))));
+#else
+    uint32_t state[4];
+
+    // Add round key step prior to the first round
+    for(int c = 0; c < 4; c++)
+    {
+        state[c] = aes_load_word(state_ptr_plain_text + c * 4) ^ aes_load_word(round_key + c * 4);
+    }
+
+    for(uint8_t curr_round = 1; curr_round < num_rounds - 1; curr_round++)
+    {
+        aes_te_round(state, round_key + curr_round * AES_BLK_LENGTH);
+    }
+
+    // Last round: Without mix columns
+    aes_te_last_round(state_ptr_cipher_text, state, round_key + (num_rounds - 1) * AES_BLK_LENGTH);
+#endif
+}
+
+#if AES_USE_AESNI
+// Function to run up to AES_LANES blocks through the aesenc instructions together
+static inline void aes_encrypt_lanes_aesni(uint8_t* lane_states, int lanes, uint8_t num_rounds, const uint8_t* round_key)
+{
+    __m128i state[AES_LANES];
+    __m128i key = _mm_loadu_si128((const __m128i*)round_key);
+
+    for(int l = 0; l < lanes; l++)
+    {
+        state[l] = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(lane_states + l * AES_BLK_LENGTH)), key);
+    }
+
+    for(uint8_t curr_round = 1; curr_round < num_rounds - 1; curr_round++)
+    {
+        key = _mm_loadu_si128((const __m128i*)(round_key + curr_round * AES_BLK_LENGTH));
+
+        for(int l = 0; l < lanes; l++)
+        {
+            state[l] = _mm_aesenc_si128(state[l], key);
+        }
+    }
+
+    key = _mm_loadu_si128((const __m128i*)(round_key + (num_rounds - 1) * AES_BLK_LENGTH));
+
+    for(int l = 0; l < lanes; l++)
+    {
+        _mm_storeu_si128((__m128i*)(lane_states + l * AES_BLK_LENGTH), _mm_aesenclast_si128(state[l], key));
+    }
+}
+#endif
+
+/* Function to encrypt state_count independent blocks in place. With AES-NI
+ * available (-maes) up to AES_LANES blocks go through each round together, so
+ * the aesenc instructions of different blocks overlap in the pipeline instead of
+ * waiting on each other.
+ */
+void aes_encrypt_states(uint8_t* states, int state_count, uint8_t key_length, uint8_t* round_key)
+{
+#if AES_USE_AESNI
+    uint8_t num_rounds = (key_length == AES128_KEY_SIZE*8) ? AES128_ROUNDS : AES256_ROUNDS;
+#endif
+
+    for(int first = 0; first < state_count; first += AES_LANES)
+    {
+        int lanes = (state_count - first < AES_LANES) ? (state_count - first) : AES_LANES;
+        uint8_t* lane_states = states + first * AES_BLK_LENGTH;
+
+#if AES_USE_AESNI
+        // A full group is passed with the constant lane count, so the states stay in registers
+        if(lanes == AES_LANES)
+        {
+            aes_encrypt_lanes_aesni(lane_states, AES_LANES, num_rounds, round_key);
+        }
+        else
+        {
+            aes_encrypt_lanes_aesni(lane_states, lanes, num_rounds, round_key);
+        }
+#else
+        // The table lookups already keep the load ports busy, so blocks are done in turn
+        for(int l = 0; l < lanes; l++)
+        {
+            aes_encrypt_state(lane_states + l * AES_BLK_LENGTH, lane_states + l * AES_BLK_LENGTH, key_length, round_key);
+        }
+#endif
+    }
+}
+
+__host__ __device__ inline uint8_t aes_galoi_mult(uint8_t num, uint8_t mult)
 {
     // Calculate the Galois product
     return (mult == 0x03) ? (((num & 0x80) ? (num << 1) ^ 0x1B : (num << 1)) ^ num) : ((mult == 0x02) ? ((num & 0x80) ? (num << 1) ^ 0x1B : (num << 1)) : num);
@@ -20,6 +20,16 @@
 #define AES128_ROUNDS               11
 #define AES256_ROUNDS               15
 
+// Number of independent blocks encrypted together by aes_encrypt_states
+#define AES_LANES                   8
+
+// AES-NI is used on the host when the compiler targets it (-maes)
+#if defined(__AES__) && !defined(__CUDA_ARCH__)
+#define AES_USE_AESNI               1
+#else
+#define AES_USE_AESNI               0
+#endif
+
 // 16 byte keys are created
 #define AES128_ROUND_KEY_LENGTH     16*AES128_ROUNDS
 #define AES256_ROUND_KEY_LENGTH     16*AES256_ROUNDS
@@ -40,6 +50,19 @@ typedef struct aes_struct
     uint8_t* cipher_text;                   // Buffer to store cipher text
 } aes_struct;
 
+// Device buffers kept between calls of aes_device_encrypt_buffer
+typedef struct aes_device_struct
+{
+    uint8_t* dev_sbox_arr;                  // S-Box, uploaded once
+    int8_t* dev_comb_arr;                   // Shift rows and mix columns constants, uploaded once
+    uint8_t* dev_round_key;                 // Round key, uploaded when it changes
+    uint8_t* dev_plain_text;                // Input of the kernel
+    uint8_t* dev_cipher_text;               // Output of the kernel
+    int capacity;                           // In bytes, of the text buffers
+    uint8_t round_key[AES256_ROUND_KEY_LENGTH]; // Copy of the round key on the device
+    uint8_t round_key_length;               // In bytes, 0 until uploaded
+} aes_device_struct;
+
 /*******************************************************************************
 * Function prototypes
 *******************************************************************************/
@@ -48,13 +71,21 @@ uint8_t aes_sbox_get_val(uint8_t byte_val);
 void aes_encrypt_buffer(aes_struct* aes_config_struct);
 void aes_encrypt_ecb(aes_struct* aes_config_struct);
 void aes_encrypt_ctr(aes_struct* aes_config_struct);
+void aes_ctr_keystream(uint8_t* keystream, int keystream_length, uint8_t* counter, uint8_t key_length, uint8_t* round_key);
+void aes_increment_counter(uint8_t* counter);
+void aes_add_counter(uint8_t* counter, uint64_t block_count);
+void aes_encrypt_buffer_host(aes_struct* aes_config_struct, int num_threads);
+void aes_device_init(aes_device_struct* device, int capacity);
+void aes_device_encrypt_buffer(aes_device_struct* device, aes_struct* aes_config_struct);
+void aes_device_release(aes_device_struct* device);
 void aes_encrypt_state(uint8_t* state_ptr_cipher_text, const uint8_t* state_ptr_plain_text, uint8_t key_length, uint8_t* round_key);
+void aes_encrypt_states(uint8_t* states, int state_count, uint8_t key_length, uint8_t* round_key);
 void aes_add_round_key(uint8_t* buffer, uint8_t* round_key);
 void aes_sub_bytes(uint8_t* buffer);
 void aes_shift_rows(uint8_t* buffer);
 void aes_mix_columns(uint8_t* buffer);
 
-__device__ uint8_t aes_galoi_mult(uint8_t num, uint8_t mult);
+__host__ __device__ uint8_t aes_galoi_mult(uint8_t num, uint8_t mult);
 __global__ void aes_ecb_gpu_encryption_kernel(const uint8_t* sbox_arr, uint8_t* round_key_arr, uint8_t round_key_length, uint8_t* plain_text_arr, int plain_text_length, uint8_t num_rounds, int8_t* comb_arr, uint8_t* cipher_text_arr);
 
 #endif /* SOURCE_AES_PARALLEL_CUH */
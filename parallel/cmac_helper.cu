@@ -0,0 +1,273 @@
+/******************************************************************************
+ * File Name    - cmac_helper.cu
+ *
+ * Description  - This cu file contains the function definitions of AES-CMAC
+ *                (NIST SP 800-38B, RFC 4493) on top of the host AES
+ ******************************************************************************/
+#include "string.h"
+
+#include "cmac_helper.cuh"
+
+#if AES_USE_AESNI
+#include <emmintrin.h>
+#endif
+
+static const uint8_t cmac_zero_block[AES_BLK_LENGTH] = {0};
+
+// Function to XOR two blocks, 16 bytes at a time. output may be one of the inputs
+static inline void cmac_xor_block(uint8_t* output, const uint8_t* input_a, const uint8_t* input_b)
+{
+#if AES_USE_AESNI
+    _mm_storeu_si128((__m128i*)output, _mm_xor_si128(_mm_loadu_si128((const __m128i*)input_a), _mm_loadu_si128((const __m128i*)input_b)));
+#else
+    uint64_t a[2], b[2];
+
+    memcpy(a, input_a, AES_BLK_LENGTH);
+    memcpy(b, input_b, AES_BLK_LENGTH);
+    a[0] ^= b[0];
+    a[1] ^= b[1];
+    memcpy(output, a, AES_BLK_LENGTH);
+#endif
+}
+
+// Function to pad an incomplete last block with 0x80 followed by zeros
+static inline void cmac_pad_block(uint8_t* output, const uint8_t* input, int length)
+{
+    memset(output, 0, AES_BLK_LENGTH);
+    memcpy(output, input, length);
+    output[length] = 0x80;
+}
+
+// Function to multiply by x in GF(2^128), used to derive the subkeys
+static void cmac_double(uint8_t* output, const uint8_t* input)
+{
+    uint8_t msb = input[0] & 0x80;
+
+    for(int i = 0; i < AES_BLK_LENGTH - 1; i++)
+    {
+        output[i] = (input[i] << 1) | (input[i + 1] >> 7);
+    }
+
+    output[AES_BLK_LENGTH - 1] = (input[AES_BLK_LENGTH - 1] << 1) ^ (msb ? 0x87 : 0x00);
+}
+
+// Function to chain one block into the CBC-MAC state
+static void cmac_process_block(cmac_struct* cmac, const uint8_t* block)
+{
+    cmac_xor_block(cmac->state, cmac->state, block);
+    aes_encrypt_state(cmac->state, cmac->state, cmac->key->key_length, cmac->key->round_key);
+}
+
+/* Function to set up a MAC key from its round key. The subkeys are derived here
+ * once instead of for every message.
+ */
+void cmac_helper_init_key(cmac_key_struct* cmac_key, const uint8_t* round_key, uint8_t key_length)
+{
+    uint8_t zero_block[AES_BLK_LENGTH] = {0};
+    uint8_t l_block[AES_BLK_LENGTH];
+
+    memcpy(cmac_key->round_key, round_key, (key_length == AES128_KEY_SIZE*8) ? AES128_ROUND_KEY_LENGTH : AES256_ROUND_KEY_LENGTH);
+    cmac_key->key_length = key_length;
+
+    // L = E(K, 0), K1 = 2L, K2 = 4L
+    aes_encrypt_state(l_block, zero_block, key_length, cmac_key->round_key);
+    cmac_double(cmac_key->k1, l_block);
+    cmac_double(cmac_key->k2, cmac_key->k1);
+}
+
+// Function to start a new message
+void cmac_helper_init(cmac_struct* cmac, cmac_key_struct* cmac_key)
+{
+    cmac->key = cmac_key;
+    memset(cmac->state, 0, AES_BLK_LENGTH);
+    cmac->buffer_length = 0;
+}
+
+/* Function to add message data. The last block is treated differently so a
+ * full buffer is only processed when more data follows.
+ */
+void cmac_helper_update(cmac_struct* cmac, const uint8_t* data, size_t data_length)
+{
+    while(data_length > 0)
+    {
+        if(cmac->buffer_length == AES_BLK_LENGTH)
+        {
+            cmac_process_block(cmac, cmac->buffer);
+            cmac->buffer_length = 0;
+        }
+
+        // Blocks which are known not to be the last one are used in place
+        while((cmac->buffer_length == 0) && (data_length > AES_BLK_LENGTH))
+        {
+            cmac_process_block(cmac, data);
+            data += AES_BLK_LENGTH;
+            data_length -= AES_BLK_LENGTH;
+        }
+
+        size_t copy_length = AES_BLK_LENGTH - cmac->buffer_length;
+
+        if(copy_length > data_length)
+        {
+            copy_length = data_length;
+        }
+
+        memcpy(cmac->buffer + cmac->buffer_length, data, copy_length);
+        cmac->buffer_length += copy_length;
+        data += copy_length;
+        data_length -= copy_length;
+    }
+}
+
+// Function to process the last block and output the 16 byte tag
+void cmac_helper_final(cmac_struct* cmac, uint8_t* tag)
+{
+    uint8_t last_block[AES_BLK_LENGTH];
+
+    if(cmac->buffer_length == AES_BLK_LENGTH)
+    {
+        cmac_xor_block(last_block, cmac->buffer, cmac->key->k1);
+    }
+    else
+    {
+        // Incomplete (or empty) last block is padded
+        cmac_pad_block(last_block, cmac->buffer, cmac->buffer_length);
+        cmac_xor_block(last_block, last_block, cmac->key->k2);
+    }
+
+    cmac_process_block(cmac, last_block);
+    memcpy(tag, cmac->state, AES_BLK_LENGTH);
+}
+
+// Function to compute the tag of a message held in one buffer
+void cmac_helper_compute_tag(cmac_key_struct* cmac_key, const uint8_t* message, size_t message_length, uint8_t* tag)
+{
+    cmac_struct cmac;
+
+    cmac_helper_init(&cmac, cmac_key);
+    cmac_helper_update(&cmac, message, message_length);
+    cmac_helper_final(&cmac, tag);
+}
+
+/* Function to compute the tags of many messages. The CBC chain of one message is
+ * serial, so CMAC_LANES messages are processed side by side and their next
+ * blocks are encrypted together by aes_encrypt_states. The messages of a group
+ * are ordered by block count, longest first, so the messages still running are
+ * always the first lanes and no copying between lanes is needed. Groups of
+ * single block messages have no chain, their last blocks are built directly in
+ * tags and encrypted there. The tag of message i is written to
+ * tags + i * AES_BLK_LENGTH.
+ */
+void cmac_helper_compute_tags(cmac_key_struct* cmac_key, const uint8_t* const* messages, const size_t* message_lengths, int message_count, uint8_t* tags)
+{
+    uint8_t states[CMAC_LANES * AES_BLK_LENGTH];
+    uint8_t last_block[AES_BLK_LENGTH];
+    int lane_message[CMAC_LANES];
+    size_t lane_blocks[CMAC_LANES];
+
+    for(int first = 0; first < message_count; first += CMAC_LANES)
+    {
+        int lanes = (message_count - first < CMAC_LANES) ? (message_count - first) : CMAC_LANES;
+        bool single_block = true;
+
+        for(int l = 0; l < lanes; l++)
+        {
+            single_block = single_block && (message_lengths[first + l] <= AES_BLK_LENGTH);
+        }
+
+        if(single_block)
+        {
+            for(int l = 0; l < lanes; l++)
+            {
+                uint8_t* tag = tags + (size_t)(first + l) * AES_BLK_LENGTH;
+
+                if(message_lengths[first + l] == AES_BLK_LENGTH)
+                {
+                    cmac_xor_block(tag, messages[first + l], cmac_key->k1);
+                }
+                else
+                {
+                    cmac_pad_block(last_block, messages[first + l], message_lengths[first + l]);
+                    cmac_xor_block(tag, last_block, cmac_key->k2);
+                }
+            }
+
+            aes_encrypt_states(tags + (size_t)first * AES_BLK_LENGTH, lanes, cmac_key->key_length, cmac_key->round_key);
+            continue;
+        }
+
+        // Insertion sort of the group by block count. An empty message has one (padded) block
+        for(int l = 0; l < lanes; l++)
+        {
+            int message = first + l;
+            size_t blocks = (message_lengths[message] == 0) ? 1 : (message_lengths[message] + AES_BLK_LENGTH - 1) / AES_BLK_LENGTH;
+            int j = l;
+
+            for(; (j > 0) && (lane_blocks[j - 1] < blocks); j--)
+            {
+                lane_blocks[j] = lane_blocks[j - 1];
+                lane_message[j] = lane_message[j - 1];
+            }
+
+            lane_blocks[j] = blocks;
+            lane_message[j] = message;
+        }
+
+        int active_lanes = lanes;
+
+        for(size_t block = 0; ; block++)
+        {
+            // Drop the lanes whose message has no block left
+            while((active_lanes > 0) && (lane_blocks[active_lanes - 1] <= block))
+            {
+                active_lanes--;
+            }
+
+            if(active_lanes == 0)
+            {
+                break;
+            }
+
+            for(int l = 0; l < active_lanes; l++)
+            {
+                const uint8_t* data = messages[lane_message[l]] + block * AES_BLK_LENGTH;
+                uint8_t* state = states + l * AES_BLK_LENGTH;
+
+                // The chain starts from a zero block
+                const uint8_t* chain = (block == 0) ? cmac_zero_block : state;
+
+                if(block + 1 < lane_blocks[l])
+                {
+                    cmac_xor_block(state, chain, data);
+                }
+                else
+                {
+                    // Last block, complete blocks use K1 and padded blocks use K2
+                    int length = message_lengths[lane_message[l]] - block * AES_BLK_LENGTH;
+
+                    if(length == AES_BLK_LENGTH)
+                    {
+                        cmac_xor_block(last_block, data, cmac_key->k1);
+                    }
+                    else
+                    {
+                        cmac_pad_block(last_block, data, length);
+                        cmac_xor_block(last_block, last_block, cmac_key->k2);
+                    }
+
+                    cmac_xor_block(state, chain, last_block);
+                }
+            }
+
+            aes_encrypt_states(states, active_lanes, cmac_key->key_length, cmac_key->round_key);
+
+            // Lanes which just processed their last block hold the tag
+            for(int l = 0; l < active_lanes; l++)
+            {
+                if(block + 1 == lane_blocks[l])
+                {
+                    memcpy(tags + (size_t)lane_message[l] * AES_BLK_LENGTH, states + l * AES_BLK_LENGTH, AES_BLK_LENGTH);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,51 @@
+/******************************************************************************
+ * File Name    - cmac_helper.cuh
+ *
+ * Description  - This is the header file for the cmac_helper code
+ ******************************************************************************/
+
+#ifndef SOURCE_CMAC_HELPER_CUH
+#define SOURCE_CMAC_HELPER_CUH
+
+#include "main.cuh"
+#include "aes_parallel.cuh"
+
+/*******************************************************************************
+* Global constants
+*******************************************************************************/
+// Messages whose CMAC chains are interleaved by cmac_helper_compute_tags
+#define CMAC_LANES                  AES_LANES
+
+/*******************************************************************************
+* Structures and enumerations
+*******************************************************************************/
+// Key schedule with its subkeys, derived once and shared by all messages
+typedef struct cmac_key_struct
+{
+    uint8_t round_key[AES256_ROUND_KEY_LENGTH];   // Round key of the MAC key
+    uint8_t key_length;                           // In bits - 128 or 256
+    uint8_t k1[AES_BLK_LENGTH];                   // Subkey for a complete last block
+    uint8_t k2[AES_BLK_LENGTH];                   // Subkey for a padded last block
+} cmac_key_struct;
+
+typedef struct cmac_struct
+{
+    cmac_key_struct* key;                         // Key of the message
+    uint8_t state[AES_BLK_LENGTH];                // Running CBC-MAC value
+    uint8_t buffer[AES_BLK_LENGTH];               // Input not yet processed
+    int buffer_length;                            // In bytes
+} cmac_struct;
+
+/*******************************************************************************
+* Function prototypes
+*******************************************************************************/
+void cmac_helper_init_key(cmac_key_struct* cmac_key, const uint8_t* round_key, uint8_t key_length);
+void cmac_helper_init(cmac_struct* cmac, cmac_key_struct* cmac_key);
+void cmac_helper_update(cmac_struct* cmac, const uint8_t* data, size_t data_length);
+void cmac_helper_final(cmac_struct* cmac, uint8_t* tag);
+void cmac_helper_compute_tag(cmac_key_struct* cmac_key, const uint8_t* message, size_t message_length, uint8_t* tag);
+void cmac_helper_compute_tags(cmac_key_struct* cmac_key, const uint8_t* const* messages, const size_t* message_lengths, int message_count, uint8_t* tags);
+
+#endif /* SOURCE_CMAC_HELPER_CUH */
+
+/* [] END OF FILE */
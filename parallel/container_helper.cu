@@ -0,0 +1,370 @@
+/******************************************************************************
+ * File Name    - container_helper.cu
+ *
+ * Description  - This cu file contains the function definitions of the chunked
+ *                encrypted container. Chunks are independent so they are
+ *                encrypted and decrypted on any number of OpenMP threads
+ ******************************************************************************/
+#include "string.h"
+#include <climits>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <omp.h>
+
+#include "container_helper.cuh"
+#include "cmac_helper.cuh"
+#include "drbg_helper.cuh"
+#include "key_helper.cuh"
+
+// Helper functions to store and load little endian integers
+static void container_store(uint8_t* buffer, uint64_t value, int length)
+{
+    for(int i = 0; i < length; i++)
+    {
+        buffer[i] = (value >> (8 * i)) & 0xff;
+    }
+}
+
+static uint64_t container_load(const uint8_t* buffer, int length)
+{
+    uint64_t value = 0;
+
+    for(int i = length - 1; i >= 0; i--)
+    {
+        value = (value << 8) | buffer[i];
+    }
+
+    return value;
+}
+
+// Function to get the file offset of a chunk
+static uint64_t container_chunk_offset(uint32_t chunk_size, uint64_t chunk)
+{
+    return CONTAINER_HEADER_LENGTH + chunk * ((uint64_t)chunk_size + CONTAINER_CHUNK_OVERHEAD);
+}
+
+// Function to get the plain text length of a chunk. Only the last chunk is shorter
+static uint32_t container_chunk_length(uint64_t data_length, uint32_t chunk_size, uint64_t chunk)
+{
+    uint64_t remaining = data_length - chunk * chunk_size;
+
+    return (remaining < chunk_size) ? (uint32_t)remaining : chunk_size;
+}
+
+// Function to get the file offset of the chunk index
+static uint64_t container_index_offset(uint64_t data_length, uint64_t chunk_count)
+{
+    return CONTAINER_HEADER_LENGTH + data_length + chunk_count * CONTAINER_CHUNK_OVERHEAD;
+}
+
+/* Function to derive the round key for encryption and the CMAC key. The derived
+ * keys are the CTR keystream of the key with the counter set to 01 00 .. 00 and
+ * 02 00 .. 00 respectively.
+ */
+static void container_derive_keys(const uint8_t* key, uint8_t* enc_round_key, cmac_key_struct* mac_key)
+{
+    uint8_t round_key[AES256_ROUND_KEY_LENGTH];
+    uint8_t mac_round_key[AES256_ROUND_KEY_LENGTH];
+    uint8_t derived_key[AES_KEY_SIZE_BYTES];
+    uint8_t counter[AES_BLK_LENGTH];
+
+    key_helper_create_round_keys(AES_MODE, AES_KEY_SIZE, key, round_key);
+
+    memset(counter, 0, AES_BLK_LENGTH);
+    counter[0] = 0x01;
+    aes_ctr_keystream(derived_key, AES_KEY_SIZE_BYTES, counter, AES_KEY_SIZE, round_key);
+    key_helper_create_round_keys(AES_MODE, AES_KEY_SIZE, derived_key, enc_round_key);
+
+    memset(counter, 0, AES_BLK_LENGTH);
+    counter[0] = 0x02;
+    aes_ctr_keystream(derived_key, AES_KEY_SIZE_BYTES, counter, AES_KEY_SIZE, round_key);
+    key_helper_create_round_keys(AES_MODE, AES_KEY_SIZE, derived_key, mac_round_key);
+    cmac_helper_init_key(mac_key, mac_round_key, AES_KEY_SIZE);
+
+    memset(round_key, 0, AES256_ROUND_KEY_LENGTH);
+    memset(mac_round_key, 0, AES256_ROUND_KEY_LENGTH);
+    memset(derived_key, 0, AES_KEY_SIZE_BYTES);
+}
+
+// Function to compute the tag of a chunk. The record starts with the nonce
+static void container_chunk_tag(cmac_key_struct* mac_key, const uint8_t* header, uint64_t chunk, const uint8_t* record, uint32_t length, uint8_t* tag)
+{
+    cmac_struct cmac;
+    uint8_t chunk_number[8];
+
+    container_store(chunk_number, chunk, 8);
+
+    cmac_helper_init(&cmac, mac_key);
+    cmac_helper_update(&cmac, header, CONTAINER_HEADER_LENGTH);
+    cmac_helper_update(&cmac, chunk_number, 8);
+    cmac_helper_update(&cmac, record, CONTAINER_NONCE_LENGTH + length);
+    cmac_helper_final(&cmac, tag);
+}
+
+// Function to release the mapping and the file of a container
+static void container_cleanup(container_struct* container)
+{
+    if(container->map != NULL)
+    {
+        munmap((void*)container->map, container->map_length);
+        container->map = NULL;
+    }
+
+    if(container->fd >= 0)
+    {
+        close(container->fd);
+        container->fd = -1;
+    }
+
+    memset(container->enc_round_key, 0, AES256_ROUND_KEY_LENGTH);
+    memset(&container->mac_key, 0, sizeof(cmac_key_struct));
+}
+
+/* Function to write data to a new container file. The file is sized up front and
+ * mapped, and every chunk is encrypted and authenticated in place by one of the
+ * OpenMP threads.
+ */
+int container_helper_write(const char* file_name, const uint8_t* key, const uint8_t* key_id, const uint8_t* data, uint64_t data_length, uint32_t chunk_size, int num_threads)
+{
+    uint8_t enc_round_key[AES256_ROUND_KEY_LENGTH];
+    cmac_key_struct mac_key;
+
+    // Chunks are encrypted with int lengths
+    if((chunk_size == 0) || (chunk_size > INT_MAX))
+    {
+        return CONTAINER_ERROR_RANGE;
+    }
+
+    uint64_t chunk_count = (data_length + chunk_size - 1) / chunk_size;
+    uint64_t index_offset = container_index_offset(data_length, chunk_count);
+    uint64_t file_length = index_offset + chunk_count * CONTAINER_INDEX_ENTRY_LENGTH + CONTAINER_TRAILER_LENGTH;
+
+    int fd = open(file_name, O_RDWR | O_CREAT | O_TRUNC, 0644);
+
+    if(fd < 0)
+    {
+        return CONTAINER_ERROR_IO;
+    }
+
+    if(ftruncate(fd, file_length) != 0)
+    {
+        close(fd);
+        return CONTAINER_ERROR_IO;
+    }
+
+    uint8_t* map = (uint8_t*)mmap(NULL, file_length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    if(map == MAP_FAILED)
+    {
+        close(fd);
+        return CONTAINER_ERROR_IO;
+    }
+
+    container_derive_keys(key, enc_round_key, &mac_key);
+
+    // Header. Reserved fields are already zero after ftruncate
+    memcpy(map, CONTAINER_MAGIC, 4);
+    map[4] = CONTAINER_VERSION;
+    map[5] = CONTAINER_ALG_AES_CTR_CMAC;
+    container_store(map + 6, AES_KEY_SIZE, 2);
+    memcpy(map + 8, key_id, CONTAINER_KEY_ID_LENGTH);
+    container_store(map + 24, chunk_size, 4);
+    container_store(map + 32, chunk_count, 8);
+    container_store(map + 40, data_length, 8);
+
+    uint8_t* index = map + index_offset;
+
+    #pragma omp parallel for schedule(dynamic) num_threads(num_threads)
+    for(long long chunk = 0; chunk < (long long)chunk_count; chunk++)
+    {
+        uint64_t offset = container_chunk_offset(chunk_size, chunk);
+        uint32_t length = container_chunk_length(data_length, chunk_size, chunk);
+        const uint8_t* plain_text = data + (uint64_t)chunk * chunk_size;
+        uint8_t* record = map + offset;
+        uint8_t* cipher_text = record + CONTAINER_NONCE_LENGTH;
+        uint8_t counter[AES_BLK_LENGTH];
+
+        // Fresh random nonce is the initial counter of the chunk
+        drbg_helper_random_bytes(record, CONTAINER_NONCE_LENGTH);
+        memcpy(counter, record, AES_BLK_LENGTH);
+
+        aes_ctr_keystream(cipher_text, length, counter, AES_KEY_SIZE, enc_round_key);
+
+        for(uint32_t i = 0; i < length; i++)
+        {
+            cipher_text[i] ^= plain_text[i];
+        }
+
+        container_chunk_tag(&mac_key, map, chunk, record, length, cipher_text + length);
+
+        container_store(index + chunk * CONTAINER_INDEX_ENTRY_LENGTH, offset, 8);
+        container_store(index + chunk * CONTAINER_INDEX_ENTRY_LENGTH + 8, length, 4);
+    }
+
+    // Trailer
+    uint8_t* trailer = map + file_length - CONTAINER_TRAILER_LENGTH;
+    container_store(trailer, index_offset, 8);
+    container_store(trailer + 8, chunk_count, 8);
+    memcpy(trailer + 16, CONTAINER_INDEX_MAGIC, 4);
+
+    memset(enc_round_key, 0, AES256_ROUND_KEY_LENGTH);
+    memset(&mac_key, 0, sizeof(cmac_key_struct));
+
+    int result = CONTAINER_SUCCESS;
+
+    if(munmap(map, file_length) != 0)
+    {
+        result = CONTAINER_ERROR_IO;
+    }
+
+    if(close(fd) != 0)
+    {
+        result = CONTAINER_ERROR_IO;
+    }
+
+    return result;
+}
+
+/* Function to open a container for reading. The file is mapped and the header,
+ * trailer and the sizes are checked, the chunks themselves are only read when
+ * they are decrypted.
+ */
+int container_helper_open(container_struct* container, const char* file_name, const uint8_t* key)
+{
+    struct stat file_stat;
+
+    container->map = NULL;
+    container->fd = open(file_name, O_RDONLY);
+
+    if((container->fd < 0) || (fstat(container->fd, &file_stat) != 0))
+    {
+        container_cleanup(container);
+        return CONTAINER_ERROR_IO;
+    }
+
+    container->map_length = file_stat.st_size;
+
+    if(container->map_length < CONTAINER_HEADER_LENGTH + CONTAINER_TRAILER_LENGTH)
+    {
+        container_cleanup(container);
+        return CONTAINER_ERROR_FORMAT;
+    }
+
+    void* map = mmap(NULL, container->map_length, PROT_READ, MAP_PRIVATE, container->fd, 0);
+
+    if(map == MAP_FAILED)
+    {
+        container_cleanup(container);
+        return CONTAINER_ERROR_IO;
+    }
+
+    container->map = (const uint8_t*)map;
+
+    const uint8_t* header = container->map;
+    const uint8_t* trailer = container->map + container->map_length - CONTAINER_TRAILER_LENGTH;
+
+    container->algorithm = header[5];
+    container->key_size = container_load(header + 6, 2);
+    memcpy(container->key_id, header + 8, CONTAINER_KEY_ID_LENGTH);
+    container->chunk_size = container_load(header + 24, 4);
+    container->chunk_count = container_load(header + 32, 8);
+    container->data_length = container_load(header + 40, 8);
+
+    uint64_t index_offset = container_load(trailer, 8);
+
+    if((memcmp(header, CONTAINER_MAGIC, 4) != 0) || (header[4] != CONTAINER_VERSION) ||
+       (memcmp(trailer + 16, CONTAINER_INDEX_MAGIC, 4) != 0) ||
+       (container->algorithm != CONTAINER_ALG_AES_CTR_CMAC) || (container->key_size != AES_KEY_SIZE) ||
+       (container->chunk_size == 0) || (container->chunk_size > INT_MAX) ||
+       (container->data_length > container->map_length) ||
+       (container->chunk_count != (container->data_length + container->chunk_size - 1) / container->chunk_size) ||
+       (container_load(trailer + 8, 8) != container->chunk_count) ||
+       (index_offset != container_index_offset(container->data_length, container->chunk_count)) ||
+       (index_offset + container->chunk_count * CONTAINER_INDEX_ENTRY_LENGTH + CONTAINER_TRAILER_LENGTH != container->map_length))
+    {
+        container_cleanup(container);
+        return CONTAINER_ERROR_FORMAT;
+    }
+
+    container->index = container->map + index_offset;
+
+    container_derive_keys(key, container->enc_round_key, &container->mac_key);
+
+    return CONTAINER_SUCCESS;
+}
+
+/* Function to decrypt chunk_count chunks starting at first_chunk into output,
+ * which must hold chunk_count * chunk_size bytes (less if the range includes the
+ * last chunk). Only the requested chunks are read. A chunk whose tag does not
+ * match is left zeroed in output and CONTAINER_ERROR_AUTH is returned.
+ */
+int container_helper_decrypt_chunks(container_struct* container, uint64_t first_chunk, uint64_t chunk_count, uint8_t* output, int num_threads)
+{
+    int result = CONTAINER_SUCCESS;
+
+    if((first_chunk > container->chunk_count) || (chunk_count > container->chunk_count - first_chunk))
+    {
+        return CONTAINER_ERROR_RANGE;
+    }
+
+    #pragma omp parallel for schedule(dynamic) num_threads(num_threads)
+    for(long long i = 0; i < (long long)chunk_count; i++)
+    {
+        uint64_t chunk = first_chunk + i;
+        const uint8_t* entry = container->index + chunk * CONTAINER_INDEX_ENTRY_LENGTH;
+        uint64_t offset = container_load(entry, 8);
+        uint32_t length = container_load(entry + 8, 4);
+        uint8_t* plain_text = output + (uint64_t)i * container->chunk_size;
+
+        // Index must agree with the fixed layout given by the header
+        if((offset != container_chunk_offset(container->chunk_size, chunk)) ||
+           (length != container_chunk_length(container->data_length, container->chunk_size, chunk)))
+        {
+            #pragma omp atomic write
+            result = CONTAINER_ERROR_FORMAT;
+            continue;
+        }
+
+        const uint8_t* record = container->map + offset;
+        const uint8_t* cipher_text = record + CONTAINER_NONCE_LENGTH;
+        uint8_t tag[CONTAINER_TAG_LENGTH];
+        uint8_t tag_diff = 0;
+
+        container_chunk_tag(&container->mac_key, container->map, chunk, record, length, tag);
+
+        // Compare every byte so the time taken does not depend on the tag
+        for(int j = 0; j < CONTAINER_TAG_LENGTH; j++)
+        {
+            tag_diff |= tag[j] ^ cipher_text[length + j];
+        }
+
+        if(tag_diff != 0)
+        {
+            memset(plain_text, 0, length);
+
+            #pragma omp atomic write
+            result = CONTAINER_ERROR_AUTH;
+            continue;
+        }
+
+        uint8_t counter[AES_BLK_LENGTH];
+
+        memcpy(counter, record, AES_BLK_LENGTH);
+        aes_ctr_keystream(plain_text, length, counter, AES_KEY_SIZE, container->enc_round_key);
+
+        for(uint32_t j = 0; j < length; j++)
+        {
+            plain_text[j] ^= cipher_text[j];
+        }
+    }
+
+    return result;
+}
+
+// Function to close a container opened for reading
+void container_helper_close(container_struct* container)
+{
+    container_cleanup(container);
+}
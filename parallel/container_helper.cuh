@@ -0,0 +1,85 @@
+/******************************************************************************
+ * File Name    - container_helper.cuh
+ *
+ * Description  - This is the header file for the container_helper code
+ ******************************************************************************/
+
+#ifndef SOURCE_CONTAINER_HELPER_CUH
+#define SOURCE_CONTAINER_HELPER_CUH
+
+#include "main.cuh"
+#include "aes_parallel.cuh"
+#include "cmac_helper.cuh"
+
+/*******************************************************************************
+* Global constants
+*******************************************************************************/
+/* File layout (all integers little endian)
+ *
+ * Header - 64 bytes
+ *      magic "AESC" (4) | version (1) | algorithm (1) | key size in bits (2) |
+ *      key id (16) | chunk size (4) | reserved (4) | chunk count (8) |
+ *      data length (8) | reserved (16)
+ * Chunk i at CONTAINER_HEADER_LENGTH + i * (chunk size + CONTAINER_CHUNK_OVERHEAD)
+ *      nonce (16) | cipher text (chunk size, last chunk may be shorter) | tag (16)
+ * Index - one entry per chunk
+ *      offset of the chunk (8) | cipher text length (4) | reserved (4)
+ * Trailer - 24 bytes, at the end of the file
+ *      index offset (8) | chunk count (8) | magic "AESI" (4) | reserved (4)
+ *
+ * The chunk is encrypted in CTR mode with the nonce as the initial counter. The
+ * tag is the AES-CMAC of header | chunk number (8) | nonce | cipher text.
+ * Encryption and MAC keys are derived from the key so one key is never used for
+ * both.
+ */
+#define CONTAINER_MAGIC             "AESC"
+#define CONTAINER_INDEX_MAGIC       "AESI"
+#define CONTAINER_VERSION           1
+
+#define CONTAINER_ALG_AES_CTR_CMAC  0x01
+
+#define CONTAINER_HEADER_LENGTH     64
+#define CONTAINER_NONCE_LENGTH      AES_BLK_LENGTH
+#define CONTAINER_TAG_LENGTH        AES_BLK_LENGTH
+#define CONTAINER_CHUNK_OVERHEAD    (CONTAINER_NONCE_LENGTH + CONTAINER_TAG_LENGTH)
+#define CONTAINER_INDEX_ENTRY_LENGTH 16
+#define CONTAINER_TRAILER_LENGTH    24
+#define CONTAINER_KEY_ID_LENGTH     16
+
+// Return values
+#define CONTAINER_SUCCESS           0
+#define CONTAINER_ERROR_IO          -1
+#define CONTAINER_ERROR_FORMAT      -2
+#define CONTAINER_ERROR_AUTH        -3
+#define CONTAINER_ERROR_RANGE       -4
+
+/*******************************************************************************
+* Structures and enumerations
+*******************************************************************************/
+typedef struct container_struct
+{
+    int fd;                                             // Descriptor of the open file
+    const uint8_t* map;                                 // Read only mapping of the file
+    size_t map_length;                                  // In bytes
+    uint8_t algorithm;                                  // CONTAINER_ALG_*
+    uint16_t key_size;                                  // In bits
+    uint8_t key_id[CONTAINER_KEY_ID_LENGTH];            // Identifies the key used
+    uint32_t chunk_size;                                // Plain text bytes per chunk
+    uint64_t chunk_count;                               // Number of chunks
+    uint64_t data_length;                               // Total plain text bytes
+    const uint8_t* index;                               // Chunk index inside the mapping
+    uint8_t enc_round_key[AES256_ROUND_KEY_LENGTH];     // Round key for CTR
+    cmac_key_struct mac_key;                            // CMAC key with its subkeys
+} container_struct;
+
+/*******************************************************************************
+* Function prototypes
+*******************************************************************************/
+int container_helper_write(const char* file_name, const uint8_t* key, const uint8_t* key_id, const uint8_t* data, uint64_t data_length, uint32_t chunk_size, int num_threads);
+int container_helper_open(container_struct* container, const char* file_name, const uint8_t* key);
+int container_helper_decrypt_chunks(container_struct* container, uint64_t first_chunk, uint64_t chunk_count, uint8_t* output, int num_threads);
+void container_helper_close(container_struct* container);
+
+#endif /* SOURCE_CONTAINER_HELPER_CUH */
+
+/* [] END OF FILE */
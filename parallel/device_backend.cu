@@ -0,0 +1,93 @@
+/******************************************************************************
+ * File Name    - device_backend.cu
+ *
+ * Description  - This cu file contains the device backends used by the work
+ *                splitter - the CUDA kernel and a simulated device which runs
+ *                on a single CPU thread
+ ******************************************************************************/
+#include <cuda.h>
+
+#include "device_backend.cuh"
+
+// Function to check if a CUDA capable GPU is present
+static bool device_backend_cuda_is_available(void)
+{
+    int device_count = 0;
+
+    return (cudaGetDeviceCount(&device_count) == cudaSuccess) && (device_count > 0);
+}
+
+// Buffers of the CUDA backend, reused by every call
+static aes_device_struct device_backend_cuda_device;
+
+// Function to create the CUDA context and the device buffers
+static void device_backend_cuda_init(int max_length)
+{
+    aes_device_init(&device_backend_cuda_device, max_length);
+}
+
+// Function to encrypt on the GPU with the buffers set up by init
+static void device_backend_cuda_encrypt_buffer(aes_struct* aes_config_struct)
+{
+    aes_device_encrypt_buffer(&device_backend_cuda_device, aes_config_struct);
+}
+
+// Function to free the device buffers
+static void device_backend_cuda_release(void)
+{
+    aes_device_release(&device_backend_cuda_device);
+}
+
+// The simulated device is a CPU thread and is always available
+static bool device_backend_sim_is_available(void)
+{
+    return true;
+}
+
+// The simulated device needs no setup
+static void device_backend_sim_init(int max_length)
+{
+}
+
+// Function to encrypt on the simulated device
+static void device_backend_sim_encrypt_buffer(aes_struct* aes_config_struct)
+{
+    aes_encrypt_buffer_host(aes_config_struct, 1);
+}
+
+static void device_backend_sim_release(void)
+{
+}
+
+/*******************************************************************************
+* Global variables
+*******************************************************************************/
+const device_backend_struct device_backend_cuda = {
+    "CUDA",
+    device_backend_cuda_is_available,
+    device_backend_cuda_init,
+    device_backend_cuda_encrypt_buffer,
+    device_backend_cuda_release
+    };
+
+const device_backend_struct device_backend_sim = {
+    "Simulated",
+    device_backend_sim_is_available,
+    device_backend_sim_init,
+    device_backend_sim_encrypt_buffer,
+    device_backend_sim_release
+    };
+
+/* Function to get the backend for DEVICE_BACKEND_CUDA or DEVICE_BACKEND_SIM. The
+ * simulated device stands in when the CUDA backend is requested but no GPU is
+ * present.
+ */
+const device_backend_struct* device_backend_get(uint8_t backend_type)
+{
+    if((backend_type == DEVICE_BACKEND_CUDA) && device_backend_cuda.is_available())
+    {
+        return &device_backend_cuda;
+    }
+
+    return &device_backend_sim;
+}
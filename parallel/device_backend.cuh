@@ -0,0 +1,43 @@
+/******************************************************************************
+ * File Name    - device_backend.cuh
+ *
+ * Description  - This is the header file for the device_backend code
+ ******************************************************************************/
+
+#ifndef SOURCE_DEVICE_BACKEND_CUH
+#define SOURCE_DEVICE_BACKEND_CUH
+
+#include "main.cuh"
+#include "aes_parallel.cuh"
+
+/*******************************************************************************
+* Structures and enumerations
+*******************************************************************************/
+/* Interface of an accelerator used by the work splitter. init is called before
+ * the first encrypt_buffer so that one time setup is not part of any measured
+ * call. encrypt_buffer must encrypt the buffer described by the AES struct and
+ * return only once the cipher text is available in host memory.
+ */
+typedef struct device_backend_struct
+{
+    const char* name;                                   // Name used in prints
+    bool (*is_available)(void);                         // True if the device can be used
+    void (*init)(int max_length);                       // Prepares buffers of up to max_length bytes
+    void (*encrypt_buffer)(aes_struct* aes_config_struct); // Encrypts in ECB or CTR mode
+    void (*release)(void);                              // Frees what init set up
+} device_backend_struct;
+
+/*******************************************************************************
+* Global variables
+*******************************************************************************/
+extern const device_backend_struct device_backend_cuda;
+extern const device_backend_struct device_backend_sim;
+
+/*******************************************************************************
+* Function prototypes
+*******************************************************************************/
+const device_backend_struct* device_backend_get(uint8_t backend_type);
+
+#endif /* SOURCE_DEVICE_BACKEND_CUH */
+
+/* [] END OF FILE */
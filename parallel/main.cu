@@ -8,7 +8,6 @@
 #include <iostream>
 #include <cstdlib>
 #include <cstring>
-#include <random>
 #include <assert.h>
 #include <chrono>
 
@@ -18,6 +17,10 @@
 #include "main.cuh"
 #include "aes_parallel.cuh"
 #include "key_helper.cuh"
+#include "drbg_helper.cuh"
+#include "split_helper.cuh"
+#include "container_helper.cuh"
+#include "cmac_helper.cuh"
 
 /*******************************************************************************
 * Global constants
@@ -96,21 +99,9 @@ int main (int argc, char* argv[])
     uint8_t* plain_text = new uint8_t[plain_text_size];
     uint8_t* key = new uint8_t[AES_KEY_SIZE_BYTES];
     
-    // Generating random numbers for both key and plain text
-    std::random_device entropy_source_input;
-    std::mt19937 generator_input(entropy_source_input()); 
-    std::uniform_int_distribution<int> dist_plain_text(0, 255);
-    std::uniform_int_distribution<int> dist_key(0, 255);
-
-    for(int i = 0; i < plain_text_size; i++)
-    {
-        plain_text[i] = dist_plain_text(generator_input);
-
-        if(i < AES_KEY_SIZE_BYTES)
-        {
-            key[i] = dist_key(generator_input);
-        }
-    }
+    // Generating random key and plain text using the AES CTR_DRBG
+    drbg_helper_random_bytes(key, AES_KEY_SIZE_BYTES);
+    drbg_helper_fill_buffer(plain_text, plain_text_size);
     encrypt_struct.plain_text = plain_text;
     encrypt_struct.plain_text_length = plain_text_size;
     encrypt_struct.key = key;
@@ -136,15 +127,8 @@ int main (int argc, char* argv[])
 
     if(encrypt_struct.aes_mode == AES_CTR)
     {
-        // Generating random numbers for the initialization vector (IV) counter
-        std::random_device entropy_source;
-        std::mt19937 generator(entropy_source()); 
-        std::uniform_int_distribution<int> dist(0, 255);
-
-        for(int i = 0; i < AES_BLK_LENGTH; i++)
-        {
-            counter[i] = dist(generator);
-        }
+        // Generating random initialization vector (IV) counter
+        drbg_helper_random_bytes(counter, AES_BLK_LENGTH);
 
         encrypt_struct.counter = counter;
     }
@@ -255,8 +239,15 @@ int main (int argc, char* argv[])
     cudaEventRecord(start_cuda);
 #endif
 
+#if ENABLE_SPLIT
+    // Split the encryption between the CPU and the device
+    split_struct split;
+    split_helper_init(&split, device_backend_get(DEVICE_BACKEND), SPLIT_CPU_THREADS);
+    split_helper_encrypt_buffer(&split, &encrypt_struct);
+#else
     // Function call for AES encryption
     aes_encrypt_buffer(&encrypt_struct);
+#endif
 
 #if TIME_CUDA
     cudaEventRecord(stop_cuda);
@@ -267,6 +258,11 @@ int main (int argc, char* argv[])
     printf("\nTime taken for AES encryption using cuda - %lf\n", ms);
 #endif
 
+#if ENABLE_SPLIT
+    printf("\nSplit between %s device and %d CPU threads - device %lld bytes, CPU %lld bytes, final device ratio %lf\n", split.device->name, split.cpu_threads, split.device_bytes, split.cpu_bytes, split.device_ratio);
+    split_helper_release(&split);
+#endif
+
 #if DEBUG | DISPLAY_INPUTS
     #if COPYABLE_FORMAT
         printf("\nPrinting cipher text values:\n");
@@ -285,6 +281,105 @@ int main (int argc, char* argv[])
     #endif
 #endif
 
+#if ENABLE_CONTAINER
+    // Single key in this example, so the key id is left as zero
+    uint8_t key_id[CONTAINER_KEY_ID_LENGTH] = {0};
+    uint8_t* decrypted = new uint8_t[plain_text_size];
+    container_struct container;
+    int container_result;
+
+    std::chrono::high_resolution_clock::time_point start_container = std::chrono::high_resolution_clock::now();
+
+    container_result = container_helper_write(CONTAINER_FILE_NAME, encrypt_struct.key, key_id, encrypt_struct.plain_text, plain_text_size, CONTAINER_CHUNK_SIZE, omp_get_max_threads());
+
+    std::chrono::high_resolution_clock::time_point end_container = std::chrono::high_resolution_clock::now();
+    printf("\nTime taken to write the container - %lf\n", std::chrono::duration<double, std::milli>(end_container - start_container).count());
+
+    if(container_result == CONTAINER_SUCCESS)
+    {
+        container_result = container_helper_open(&container, CONTAINER_FILE_NAME, encrypt_struct.key);
+    }
+
+    if(container_result == CONTAINER_SUCCESS)
+    {
+        start_container = std::chrono::high_resolution_clock::now();
+
+        container_result = container_helper_decrypt_chunks(&container, 0, container.chunk_count, decrypted, omp_get_max_threads());
+
+        end_container = std::chrono::high_resolution_clock::now();
+        printf("\nTime taken to decrypt the container - %lf\n", std::chrono::duration<double, std::milli>(end_container - start_container).count());
+
+        container_helper_close(&container);
+    }
+
+    if((container_result != CONTAINER_SUCCESS) || (memcmp(decrypted, encrypt_struct.plain_text, plain_text_size) != 0))
+    {
+        printf("ERROR: Container round trip failed with %d\n", container_result);
+    }
+
+    delete [] decrypted;
+#endif
+
+#if TIME_CMAC
+    /* Tags per second for short messages with the MAC key set up once. Each
+     * length is tagged one message at a time and then with the multi-lane batch,
+     * which must give the same tags.
+     */
+    const int cmac_lengths[] = {16, 32, 64, 128, 256};
+    cmac_key_struct cmac_key;
+    uint8_t* cmac_data = new uint8_t[(size_t)CMAC_BENCH_MESSAGES * 256];
+    const uint8_t** cmac_messages = new const uint8_t*[CMAC_BENCH_MESSAGES];
+    size_t* cmac_message_lengths = new size_t[CMAC_BENCH_MESSAGES];
+    uint8_t* serial_tags = new uint8_t[(size_t)CMAC_BENCH_MESSAGES * AES_BLK_LENGTH];
+    uint8_t* batch_tags = new uint8_t[(size_t)CMAC_BENCH_MESSAGES * AES_BLK_LENGTH];
+
+    cmac_helper_init_key(&cmac_key, encrypt_struct.round_key, encrypt_struct.aes_key_length);
+    drbg_helper_fill_buffer(cmac_data, CMAC_BENCH_MESSAGES * 256);
+
+    // Touch the tag buffers so the first timed run does not pay for page faults
+    memset(serial_tags, 0, (size_t)CMAC_BENCH_MESSAGES * AES_BLK_LENGTH);
+    memset(batch_tags, 0, (size_t)CMAC_BENCH_MESSAGES * AES_BLK_LENGTH);
+
+    printf("\nAES-CMAC with %d lanes%s\n", CMAC_LANES, AES_USE_AESNI ? " using AES-NI" : "");
+
+    for(int length : cmac_lengths)
+    {
+        for(int i = 0; i < CMAC_BENCH_MESSAGES; i++)
+        {
+            cmac_messages[i] = cmac_data + (size_t)i * length;
+            cmac_message_lengths[i] = length;
+        }
+
+        std::chrono::high_resolution_clock::time_point start_cmac = std::chrono::high_resolution_clock::now();
+
+        for(int i = 0; i < CMAC_BENCH_MESSAGES; i++)
+        {
+            cmac_helper_compute_tag(&cmac_key, cmac_messages[i], length, serial_tags + (size_t)i * AES_BLK_LENGTH);
+        }
+
+        std::chrono::high_resolution_clock::time_point end_cmac = std::chrono::high_resolution_clock::now();
+        double serial_ms = std::chrono::duration<double, std::milli>(end_cmac - start_cmac).count();
+
+        start_cmac = std::chrono::high_resolution_clock::now();
+        cmac_helper_compute_tags(&cmac_key, cmac_messages, cmac_message_lengths, CMAC_BENCH_MESSAGES, batch_tags);
+        end_cmac = std::chrono::high_resolution_clock::now();
+        double batch_ms = std::chrono::duration<double, std::milli>(end_cmac - start_cmac).count();
+
+        printf("%3d byte messages - %.0lf tags/s serial, %.0lf tags/s batched\n", length, CMAC_BENCH_MESSAGES * 1000.0 / serial_ms, CMAC_BENCH_MESSAGES * 1000.0 / batch_ms);
+
+        if(memcmp(serial_tags, batch_tags, (size_t)CMAC_BENCH_MESSAGES * AES_BLK_LENGTH) != 0)
+        {
+            printf("ERROR: Batched CMAC tags do not match for %d byte messages\n", length);
+        }
+    }
+
+    delete [] cmac_data;
+    delete [] cmac_messages;
+    delete [] cmac_message_lengths;
+    delete [] serial_tags;
+    delete [] batch_tags;
+#endif
+
     // Deallocate memory
     delete [] cipher;
     delete [] encrypt_struct.round_key;
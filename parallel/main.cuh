@@ -53,6 +53,36 @@
 #define ENABLE_OPENMP               0
 #define ENABLE_CUDA                 1
 
+/* ENABLE_SPLIT   - Splits the encryption between the CPU and a device backend
+ * DEVICE_BACKEND - Device used by the split. DEVICE_BACKEND_CUDA falls back to
+ *                  DEVICE_BACKEND_SIM (a CPU thread) when no GPU is present
+ * SPLIT_CPU_THREADS - OpenMP threads for the CPU share. One core is left to
+ *                  drive the device
+ *
+ * Note - The split needs more than one core, see --cpus-per-task in taskrun.sh
+ */
+#define ENABLE_SPLIT                0
+#define DEVICE_BACKEND              DEVICE_BACKEND_CUDA
+#define DEVICE_BACKEND_CUDA         0x00
+#define DEVICE_BACKEND_SIM          0x01
+#define SPLIT_CPU_THREADS           (omp_get_max_threads() - 1)
+
+/* ENABLE_CONTAINER     - Writes the plain text to an encrypted container file
+ *                        and decrypts it back on all OpenMP threads
+ * CONTAINER_FILE_NAME  - Path of the container file
+ * CONTAINER_CHUNK_SIZE - Plain text bytes per chunk of the container
+ */
+#define ENABLE_CONTAINER            0
+#define CONTAINER_FILE_NAME         "aes_output.aesc"
+#define CONTAINER_CHUNK_SIZE        (1024*1024)
+
+/* TIME_CMAC           - Benchmarks AES-CMAC tags per second for short messages,
+ *                       one message at a time against the multi-lane batch
+ * CMAC_BENCH_MESSAGES - Messages tagged for each message length
+ */
+#define TIME_CMAC                   0
+#define CMAC_BENCH_MESSAGES         (1 << 18)
+
 /* TIME_NAIVE  - Enable timing of naive key generation
  * TIME_OPENMP - Enable timing of OpenMP key generation
  * TIME_CUDA   - Enable timing of CUDA AES implementation
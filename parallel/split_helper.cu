@@ -0,0 +1,140 @@
+/******************************************************************************
+ * File Name    - split_helper.cu
+ *
+ * Description  - This cu file contains the function definitions of the work
+ *                splitter which encrypts a buffer on the CPU and a device
+ *                backend at the same time
+ ******************************************************************************/
+#include "string.h"
+#include <chrono>
+#include <thread>
+#include <algorithm>
+
+#include "split_helper.cuh"
+
+// Function to create the AES struct for a part of the buffer
+static void split_create_part(aes_struct* part, uint8_t* counter, const aes_struct* aes_config_struct, int offset, int length)
+{
+    *part = *aes_config_struct;
+    part->plain_text = aes_config_struct->plain_text + offset;
+    part->cipher_text = aes_config_struct->cipher_text + offset;
+    part->plain_text_length = length;
+
+    if(aes_config_struct->aes_mode == AES_CTR)
+    {
+        // Counter of the first block of the part
+        memcpy(counter, aes_config_struct->counter, AES_BLK_LENGTH);
+        aes_add_counter(counter, offset / AES_BLK_LENGTH);
+        part->counter = counter;
+    }
+}
+
+// Function to fold a new measurement into a throughput estimate
+static double split_update_throughput(double throughput, int length, double duration_ms)
+{
+    // Guard against the timer resolution for very short runs
+    double measured = length / std::max(duration_ms, 1e-3);
+
+    if(throughput == 0)
+    {
+        return measured;
+    }
+
+    return SPLIT_SMOOTHING * measured + (1 - SPLIT_SMOOTHING) * throughput;
+}
+
+/* Function to initialize the splitter. The device is set up here so that
+ * context creation and buffer allocation are not part of the first measurement.
+ */
+void split_helper_init(split_struct* split, const device_backend_struct* device, int cpu_threads)
+{
+    device->init(SPLIT_SEGMENT_LENGTH);
+
+    split->device = device;
+    split->cpu_threads = (cpu_threads > 0) ? cpu_threads : 1;
+    split->device_ratio = SPLIT_INITIAL_RATIO;
+    split->device_throughput = 0;
+    split->cpu_throughput = 0;
+    split->device_bytes = 0;
+    split->cpu_bytes = 0;
+}
+
+/* Function to encrypt the buffer on the device and the CPU. Each segment is split
+ * at device_ratio, the device part is driven from a separate host thread while
+ * the CPU part runs on the OpenMP threads. After each segment the ratio is set
+ * so that both sides would have taken the same time. The first segment is a
+ * short probe as long as one of the throughputs is not known.
+ */
+void split_helper_encrypt_buffer(split_struct* split, aes_struct* aes_config_struct)
+{
+    int segment_length;
+
+    for(int offset = 0; offset < aes_config_struct->plain_text_length; offset += segment_length)
+    {
+        bool measured = (split->device_throughput > 0) && (split->cpu_throughput > 0);
+
+        segment_length = std::min(measured ? SPLIT_SEGMENT_LENGTH : SPLIT_PROBE_LENGTH, aes_config_struct->plain_text_length - offset);
+        int device_length = ((int)(segment_length * split->device_ratio) / SPLIT_ALIGNMENT) * SPLIT_ALIGNMENT;
+        int cpu_length = segment_length - device_length;
+        double device_ms = 0, cpu_ms = 0;
+
+        aes_struct device_part, cpu_part;
+        uint8_t device_counter[AES_BLK_LENGTH], cpu_counter[AES_BLK_LENGTH];
+
+        split_create_part(&device_part, device_counter, aes_config_struct, offset, device_length);
+        split_create_part(&cpu_part, cpu_counter, aes_config_struct, offset + device_length, cpu_length);
+
+        std::thread device_thread;
+
+        if(device_length > 0)
+        {
+            device_thread = std::thread([&]()
+            {
+                std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+                split->device->encrypt_buffer(&device_part);
+                device_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+            });
+        }
+
+        if(cpu_length > 0)
+        {
+            std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+            aes_encrypt_buffer_host(&cpu_part, split->cpu_threads);
+            cpu_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        }
+
+        if(device_thread.joinable())
+        {
+            device_thread.join();
+        }
+
+        if(device_length > 0)
+        {
+            split->device_throughput = split_update_throughput(split->device_throughput, device_length, device_ms);
+            split->device_bytes += device_length;
+        }
+
+        if(cpu_length > 0)
+        {
+            split->cpu_throughput = split_update_throughput(split->cpu_throughput, cpu_length, cpu_ms);
+            split->cpu_bytes += cpu_length;
+        }
+
+        // Share proportional to throughput, once both sides are measured
+        if((split->device_throughput > 0) && (split->cpu_throughput > 0))
+        {
+            split->device_ratio = split->device_throughput / (split->device_throughput + split->cpu_throughput);
+            split->device_ratio = std::min(std::max(split->device_ratio, SPLIT_MIN_RATIO), 1 - SPLIT_MIN_RATIO);
+        }
+
+#if DEBUG
+        printf("\nSegment at %d - device %d bytes in %lf ms, CPU %d bytes in %lf ms, new ratio %lf\n", offset, device_length, device_ms, cpu_length, cpu_ms, split->device_ratio);
+#endif
+    }
+}
+
+// Function to release the device used by the splitter
+void split_helper_release(split_struct* split)
+{
+    split->device->release();
+}
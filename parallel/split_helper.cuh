@@ -0,0 +1,60 @@
+/******************************************************************************
+ * File Name    - split_helper.cuh
+ *
+ * Description  - This is the header file for the split_helper code
+ ******************************************************************************/
+
+#ifndef SOURCE_SPLIT_HELPER_CUH
+#define SOURCE_SPLIT_HELPER_CUH
+
+#include "main.cuh"
+#include "aes_parallel.cuh"
+#include "device_backend.cuh"
+
+/*******************************************************************************
+* Global constants
+*******************************************************************************/
+// The buffer is split segment by segment so the ratio can adapt within a buffer
+#define SPLIT_SEGMENT_LENGTH        (16*1024*1024)
+
+/* Until both throughputs are measured the segments are only this long, so the
+ * bulk of the buffer is split with a measured ratio
+ */
+#define SPLIT_PROBE_LENGTH          (1024*1024)
+
+// Device share is a multiple of the CUDA block size
+#define SPLIT_ALIGNMENT             THREADS_PER_BLOCK
+
+// Device share used before any throughput is measured
+#define SPLIT_INITIAL_RATIO         0.5
+
+// Weight of the latest measurement in the throughput estimate
+#define SPLIT_SMOOTHING             0.5
+
+// Each side keeps at least this share so that its throughput stays measured
+#define SPLIT_MIN_RATIO             0.02
+
+/*******************************************************************************
+* Structures and enumerations
+*******************************************************************************/
+typedef struct split_struct
+{
+    const device_backend_struct* device;                // Accelerator side of the split
+    int cpu_threads;                                    // OpenMP threads of the CPU side
+    double device_ratio;                                // Share of each segment sent to the device
+    double device_throughput;                           // In bytes per ms, 0 until measured
+    double cpu_throughput;                              // In bytes per ms, 0 until measured
+    long long device_bytes;                             // Total bytes encrypted by the device
+    long long cpu_bytes;                                // Total bytes encrypted by the CPU
+} split_struct;
+
+/*******************************************************************************
+* Function prototypes
+*******************************************************************************/
+void split_helper_init(split_struct* split, const device_backend_struct* device, int cpu_threads);
+void split_helper_encrypt_buffer(split_struct* split, aes_struct* aes_config_struct);
+void split_helper_release(split_struct* split);
+
+#endif /* SOURCE_SPLIT_HELPER_CUH */
+
+/* [] END OF FILE */
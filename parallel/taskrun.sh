@@ -1,7 +1,7 @@
 #!/usr/bin/env zsh
 #SBATCH -J AESSlurm
 #SBATCH -p wacc
-#SBATCH --nodes=1 --cpus-per-task=1
+#SBATCH --nodes=1 --cpus-per-task=8
 #SBATCH --gres=gpu:1
 #SBATCH -t 0-0:10:00
 #SBATCH -o AESSlurm.out -e AESSlurm.err
@@ -10,7 +10,7 @@
 module load nvidia/cuda/11.6.0
 
 # Compile the code
-nvcc main.cu aes_parallel.cu key_helper.cu -Xcompiler -O3 -Xcompiler -Wall -Xptxas -O3 -std c++17 -o main -Xcompiler -fopenmp
+nvcc main.cu aes_parallel.cu key_helper.cu drbg_helper.cu device_backend.cu split_helper.cu cmac_helper.cu container_helper.cu -Xcompiler -O3 -Xcompiler -Wall -Xptxas -O3 -std c++17 -o main -Xcompiler -fopenmp -Xcompiler -maes
 
 # Command to run the code for default inputs
 ./main